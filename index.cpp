@@ -0,0 +1,505 @@
+#include "index.h"
+#include "lex.h"
+#include "summary.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ * Index file layout (all integers little-endian, as written by the host):
+ *
+ *   IndexHeader
+ *   string data      file paths and term keys, not NUL-terminated
+ *   posting data     one varint-encoded posting list per term
+ *   FileRecord[fileCount]
+ *   TermRecord[termCount]   sorted by key, for binary search
+ *
+ * A term key is a kind character ('I', 'N' or 'S') followed by the
+ * lowercased lexeme. A posting list is the posting count followed by
+ * (file delta, line, column) triples; the line is stored as a delta
+ * when the file delta is zero.
+ */
+
+namespace {
+
+const char indexMagic[8] = {'S', 'A', 'D', 'L', 'I', 'D', 'X', '1'};
+const uint32_t indexVersion = 1;
+
+// Stored as the mtime of a file that failed to lex, so it never looks unchanged.
+const int64_t failedMtime = INT64_MIN;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t fileCount;
+    uint32_t termCount;
+    uint32_t reserved;
+    uint64_t fileTableOff;
+    uint64_t termTableOff;
+};
+
+struct FileRecord {
+    uint64_t pathOff;
+    uint32_t pathLen;
+    uint32_t reserved;
+    int64_t mtime;
+    uint64_t size;
+};
+
+struct TermRecord {
+    uint64_t keyOff;
+    uint64_t postOff;
+    uint32_t keyLen;
+    uint32_t postLen;
+};
+
+// One occurrence of a term.
+struct Posting {
+    uint32_t file;
+    uint32_t line;
+    uint32_t column;
+
+    bool operator<(const Posting& other) const {
+        if (file != other.file) return file < other.file;
+        if (line != other.line) return line < other.line;
+        return column < other.column;
+    }
+};
+
+// An indexed source file and the stat data used to detect changes.
+struct FileEntry {
+    string path;
+    int64_t mtime;
+    uint64_t size;
+};
+
+// Appends v to out as a base-128 varint.
+void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+// Reads a varint from [p, end). Returns false on truncated input.
+bool getVarint(const unsigned char*& p, const unsigned char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Encodes a sorted posting list.
+string encodePostings(const vector<Posting>& postings) {
+    string out;
+    putVarint(out, postings.size());
+    uint32_t prevFile = 0, prevLine = 0;
+    for (const auto& p : postings) {
+        uint32_t fileDelta = p.file - prevFile;
+        putVarint(out, fileDelta);
+        putVarint(out, fileDelta == 0 ? p.line - prevLine : p.line);
+        putVarint(out, p.column);
+        prevFile = p.file;
+        prevLine = p.line;
+    }
+    return out;
+}
+
+// Decodes a posting list written by encodePostings.
+bool decodePostings(const unsigned char* p, const unsigned char* end, vector<Posting>& postings) {
+    uint64_t count, fileDelta, line, column;
+    if (!getVarint(p, end, count)) {
+        return false;
+    }
+    uint32_t file = 0, prevLine = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (!getVarint(p, end, fileDelta) || !getVarint(p, end, line) || !getVarint(p, end, column)) {
+            return false;
+        }
+        file += fileDelta;
+        prevLine = fileDelta == 0 ? prevLine + line : line;
+        postings.push_back({file, prevLine, static_cast<uint32_t>(column)});
+    }
+    return true;
+}
+
+// Lowercases a lexeme for case-insensitive lookup.
+string foldCase(string s) {
+    for (char& c : s) {
+        c = tolower(c);
+    }
+    return s;
+}
+
+// Read-only view of an index file mapped into memory.
+class MappedIndex {
+    int fd = -1;
+    const unsigned char* base = nullptr;
+    size_t length = 0;
+    IndexHeader header;
+
+    bool inBounds(uint64_t off, uint64_t len) const {
+        return off <= length && len <= length - off;
+    }
+
+public:
+    MappedIndex() = default;
+    MappedIndex(const MappedIndex&) = delete;
+    MappedIndex& operator=(const MappedIndex&) = delete;
+
+    ~MappedIndex() {
+        if (base) munmap(const_cast<unsigned char*>(base), length);
+        if (fd >= 0) close(fd);
+    }
+
+    bool Open(const string& path, string& error) {
+        fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            error = "CANNOT OPEN THE INDEX " + path;
+            return false;
+        }
+        length = st.st_size;
+        if (length < sizeof(IndexHeader)) {
+            error = "Invalid index file " + path;
+            return false;
+        }
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            error = "CANNOT MAP THE INDEX " + path;
+            return false;
+        }
+        base = static_cast<const unsigned char*>(addr);
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0 || header.version != indexVersion
+            || !inBounds(header.fileTableOff, uint64_t(header.fileCount) * sizeof(FileRecord))
+            || !inBounds(header.termTableOff, uint64_t(header.termCount) * sizeof(TermRecord))) {
+            error = "Invalid index file " + path;
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t FileCount() const { return header.fileCount; }
+    uint32_t TermCount() const { return header.termCount; }
+
+    bool GetFile(uint32_t i, FileEntry& entry) const {
+        FileRecord rec;
+        memcpy(&rec, base + header.fileTableOff + uint64_t(i) * sizeof(FileRecord), sizeof(rec));
+        if (!inBounds(rec.pathOff, rec.pathLen)) return false;
+        entry.path.assign(reinterpret_cast<const char*>(base + rec.pathOff), rec.pathLen);
+        entry.mtime = rec.mtime;
+        entry.size = rec.size;
+        return true;
+    }
+
+    TermRecord GetTerm(uint32_t i) const {
+        TermRecord rec;
+        memcpy(&rec, base + header.termTableOff + uint64_t(i) * sizeof(TermRecord), sizeof(rec));
+        return rec;
+    }
+
+    bool GetKey(const TermRecord& rec, string& key) const {
+        if (!inBounds(rec.keyOff, rec.keyLen)) return false;
+        key.assign(reinterpret_cast<const char*>(base + rec.keyOff), rec.keyLen);
+        return true;
+    }
+
+    bool GetPostings(const TermRecord& rec, vector<Posting>& postings) const {
+        if (!inBounds(rec.postOff, rec.postLen)) return false;
+        return decodePostings(base + rec.postOff, base + rec.postOff + rec.postLen, postings);
+    }
+
+    // Binary search over the sorted term table. Returns -1 if key is absent.
+    long FindTerm(const string& key) const {
+        long lo = 0, hi = long(header.termCount) - 1;
+        while (lo <= hi) {
+            long mid = lo + (hi - lo) / 2;
+            TermRecord rec = GetTerm(mid);
+            if (!inBounds(rec.keyOff, rec.keyLen)) return -1;
+            int cmp = memcmp(base + rec.keyOff, key.data(), min<size_t>(rec.keyLen, key.size()));
+            if (cmp == 0) {
+                cmp = rec.keyLen < key.size() ? -1 : (rec.keyLen > key.size() ? 1 : 0);
+            }
+            if (cmp == 0) return mid;
+            if (cmp < 0) lo = mid + 1;
+            else hi = mid - 1;
+        }
+        return -1;
+    }
+};
+
+// Lexes one file and appends its identifier and literal postings to terms.
+// Returns false if the file cannot be read or has a lexical error; the
+// caller then discards whatever was added to terms.
+bool lexFile(const string& path, uint32_t fileId, map<string, vector<Posting>>& terms) {
+    ifstream infile(path);
+    if (!infile) {
+        cout << "CANNOT OPEN THE FILE " << path << endl;
+        return false;
+    }
+    stringstream buffer;
+    buffer << infile.rdbuf();
+    string content = buffer.str();
+
+    // Offsets of the first character of every line, for column numbers.
+    vector<size_t> lineStarts(1, 0);
+    for (size_t i = 0; i < content.size(); i++) {
+        if (content[i] == '\n') lineStarts.push_back(i + 1);
+    }
+
+    istringstream in(content);
+    int lineNumber = 1;
+    LexItem token;
+    while ((token = getNextToken(in, lineNumber)).GetToken() != DONE) {
+        if (token.GetToken() == ERR) {
+            cout << path << ": " << token;
+            return false;
+        }
+
+        char kind;
+        size_t sourceLen = token.GetLexeme().size();
+        switch (classifyToken(token.GetToken())) {
+            case CLASS_IDENT: kind = 'I'; break;
+            case CLASS_NUMERIC: kind = 'N'; break;
+            case CLASS_STRING: kind = 'S'; sourceLen += 2; break; // Opening and closing quotes.
+            default: continue;
+        }
+
+        // The lexer leaves the stream just past the token, or failed at EOF.
+        streamoff pos = in.tellg();
+        size_t end = pos < 0 ? content.size() : static_cast<size_t>(pos);
+        size_t start = end >= sourceLen ? end - sourceLen : 0;
+        size_t lineStart = *(upper_bound(lineStarts.begin(), lineStarts.end(), start) - 1);
+
+        Posting posting = {fileId, static_cast<uint32_t>(token.GetLinenum()), static_cast<uint32_t>(start - lineStart + 1)};
+        terms[kind + foldCase(token.GetLexeme())].push_back(posting);
+    }
+    return true;
+}
+
+// Returns the canonical path of a file together with its stat data.
+bool statFile(const string& path, FileEntry& entry) {
+    struct stat st;
+    char resolved[PATH_MAX];
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || !realpath(path.c_str(), resolved)) {
+        return false;
+    }
+    entry.path = resolved;
+    entry.mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    entry.size = st.st_size;
+    return true;
+}
+
+// Serializes the index and atomically replaces indexPath with it.
+bool writeIndex(const string& indexPath, const vector<FileEntry>& files, map<string, vector<Posting>>& terms) {
+    string data(sizeof(IndexHeader), '\0');
+
+    vector<FileRecord> fileRecords;
+    for (const auto& f : files) {
+        fileRecords.push_back({data.size(), static_cast<uint32_t>(f.path.size()), 0, f.mtime, f.size});
+        data += f.path;
+    }
+
+    // std::map iterates in key order, which keeps the term table sorted.
+    vector<TermRecord> termRecords;
+    for (auto& term : terms) {
+        termRecords.push_back({data.size(), 0, static_cast<uint32_t>(term.first.size()), 0});
+        data += term.first;
+    }
+    size_t i = 0;
+    for (auto& term : terms) {
+        sort(term.second.begin(), term.second.end());
+        string encoded = encodePostings(term.second);
+        termRecords[i].postOff = data.size();
+        termRecords[i].postLen = encoded.size();
+        data += encoded;
+        i++;
+    }
+
+    IndexHeader header = {};
+    memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.version = indexVersion;
+    header.fileCount = files.size();
+    header.termCount = termRecords.size();
+    header.fileTableOff = data.size();
+    data.append(reinterpret_cast<const char*>(fileRecords.data()), fileRecords.size() * sizeof(FileRecord));
+    header.termTableOff = data.size();
+    data.append(reinterpret_cast<const char*>(termRecords.data()), termRecords.size() * sizeof(TermRecord));
+    memcpy(&data[0], &header, sizeof(header));
+
+    string tmpPath = indexPath + ".tmp";
+    ofstream out(tmpPath, ios::binary | ios::trunc);
+    out.write(data.data(), data.size());
+    out.close();
+    if (!out || rename(tmpPath.c_str(), indexPath.c_str()) != 0) {
+        cout << "CANNOT WRITE THE INDEX " << indexPath << endl;
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int buildIndex(const string& indexPath, const vector<string>& paths) {
+    vector<FileEntry> files;
+    map<string, vector<Posting>> terms;
+    set<string> indexed;
+    vector<string> toLex;
+
+    // Carry over unchanged files from an existing index without lexing them again.
+    struct stat st;
+    if (stat(indexPath.c_str(), &st) == 0) {
+        MappedIndex old;
+        string error;
+        if (!old.Open(indexPath, error)) {
+            cout << error << endl;
+            return 1;
+        }
+
+        map<uint32_t, uint32_t> remap;
+        for (uint32_t i = 0; i < old.FileCount(); i++) {
+            FileEntry entry, current;
+            if (!old.GetFile(i, entry)) {
+                cout << "Invalid index file " << indexPath << endl;
+                return 1;
+            }
+            if (!statFile(entry.path, current)) {
+                continue; // The file is gone; drop it.
+            }
+            if (current.mtime == entry.mtime && current.size == entry.size) {
+                remap[i] = files.size();
+                files.push_back(entry);
+                indexed.insert(entry.path);
+            }
+            else {
+                toLex.push_back(entry.path);
+            }
+        }
+
+        for (uint32_t i = 0; i < old.TermCount(); i++) {
+            TermRecord rec = old.GetTerm(i);
+            string key;
+            vector<Posting> postings;
+            if (!old.GetKey(rec, key) || !old.GetPostings(rec, postings)) {
+                cout << "Invalid index file " << indexPath << endl;
+                return 1;
+            }
+            for (const auto& p : postings) {
+                auto it = remap.find(p.file);
+                if (it != remap.end()) {
+                    terms[key].push_back({it->second, p.line, p.column});
+                }
+            }
+        }
+    }
+
+    for (const auto& path : paths) {
+        toLex.push_back(path);
+    }
+
+    int lexed = 0;
+    int status = 0;
+    for (const auto& path : toLex) {
+        FileEntry entry;
+        if (!statFile(path, entry)) {
+            cout << "CANNOT OPEN THE FILE " << path << endl;
+            status = 1;
+            continue;
+        }
+        if (!indexed.insert(entry.path).second) {
+            continue; // Already indexed and unchanged, or listed twice.
+        }
+        uint32_t fileId = files.size();
+        map<string, vector<Posting>> fileTerms;
+        if (lexFile(entry.path, fileId, fileTerms)) {
+            for (auto& term : fileTerms) {
+                vector<Posting>& postings = terms[term.first];
+                postings.insert(postings.end(), term.second.begin(), term.second.end());
+            }
+        }
+        else {
+            // Keep the file without postings and with an mtime no file has, so it is lexed again next time.
+            entry.mtime = failedMtime;
+            status = 1;
+        }
+        files.push_back(entry);
+        lexed++;
+    }
+
+    if (!writeIndex(indexPath, files, terms)) {
+        return 1;
+    }
+
+    cout << "Indexed Files: " << files.size() << endl;
+    cout << "Lexed Files: " << lexed << endl;
+    cout << "Terms: " << terms.size() << endl;
+    return status;
+}
+
+int queryIndex(const string& indexPath, const string& term, char kind) {
+    MappedIndex index;
+    string error;
+    if (!index.Open(indexPath, error)) {
+        cout << error << endl;
+        return 1;
+    }
+
+    const char kinds[] = {'I', 'N', 'S'};
+    const char* labels[] = {"IDENTIFIER", "NUMERIC CONSTANT", "CHARACTER OR STRING"};
+    bool found = false;
+
+    for (int k = 0; k < 3; k++) {
+        if (kind != 0 && kind != kinds[k]) continue;
+
+        long i = index.FindTerm(kinds[k] + foldCase(term));
+        if (i < 0) continue;
+
+        vector<Posting> postings;
+        if (!index.GetPostings(index.GetTerm(i), postings)) {
+            cout << "Invalid index file " << indexPath << endl;
+            return 1;
+        }
+
+        found = true;
+        cout << labels[k] << ": " << term << " (" << postings.size() << ")" << endl;
+        FileEntry entry;
+        uint32_t current = UINT32_MAX;
+        for (const auto& p : postings) {
+            if (p.file != current) {
+                if (p.file >= index.FileCount() || !index.GetFile(p.file, entry)) {
+                    cout << "Invalid index file " << indexPath << endl;
+                    return 1;
+                }
+                current = p.file;
+            }
+            cout << entry.path << ":" << p.line << ":" << p.column << endl;
+        }
+    }
+
+    if (!found) {
+        cout << "No matches for {" << term << "}" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * index.h
+ *
+ * Persistent inverted index of identifiers and literals.
+*/
+
+#ifndef INDEX_H_
+#define INDEX_H_
+
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Builds the index at indexPath, or updates it if it already exists.
+// Files already in the index are kept; only new or modified files
+// (by size and modification time) are lexed again, and files that no
+// longer exist are dropped. Returns the process exit code.
+extern int buildIndex(const string& indexPath, const vector<string>& files);
+
+// Prints every (file, line, column) where term occurs. kind selects
+// identifiers ('I'), numeric constants ('N') or string and character
+// constants ('S'); 0 searches all three. Returns the process exit code.
+extern int queryIndex(const string& indexPath, const string& term, char kind);
+
+
+#endif /* INDEX_H_ */
@@ -64,6 +64,8 @@ public:
 
 
 
+// Keyword map defined in lex.cpp, keyed by the uppercase keyword.
+extern map<string, Token> keywords;
 extern ostream& operator<<(ostream& out, const LexItem& tok);
 extern LexItem id_or_kw(const string& lexeme, int linenum);
 extern LexItem getNextToken(istream& in, int& linenum);
@@ -5,12 +5,12 @@
 #include <vector>
 #include <algorithm>
 #include "lex.h"
+#include "index.h"
+#include "watch.h"
+#include "summary.h"
 
 using namespace std;
 
-// External declaration of the keywords map from the lexer.
-extern const map<string, Token> keywords;
-
 int main(int argc, char* argv[]) {
     // Check if the input file is provided as a command-line argument.
     if (argc < 2) {
@@ -18,26 +18,44 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Custom comparator for case-insensitive string comparison.
-    struct CaseInsensitiveComp {
-        bool operator()(const string& a, const string& b) const {
-            string lowerA = a, lowerB = b;
-            // Convert both strings to lowercase for comparison.
-            for (size_t i = 0; i < b.length(); i++) {
-                lowerB[i] = tolower(b[i]);
-            }
-            for (size_t i = 0; i < a.length(); i++) {
-                lowerA[i] = tolower(a[i]);
-            }
-            return lowerB > lowerA;
+    // Index mode: build or incrementally update a persistent token index.
+    if (string(argv[1]) == "-index") {
+        if (argc < 3) {
+            cout << "Usage: -index <index_file> [input_file]..." << endl;
+            return 1;
         }
-    };
-
-    // Sets to store different types of constants and identifiers.
-    set<string> numericConsts; // Stores numeric constants (integers and floats).
-    set<string, CaseInsensitiveComp> identifiers; // Stores identifiers (case-insensitive).
-    set<string> stringAndCharConsts; // Stores string and character constants.
-
+        return buildIndex(argv[2], vector<string>(argv + 3, argv + argc));
+    }
+    
+    // Query mode: look up a term in an existing index without lexing.
+    if (string(argv[1]) == "-query") {
+        char kind = 0; // Search all token kinds by default.
+        int termArg = 3;
+        string arg = argc > 3 ? argv[3] : "";
+        if (arg == "-id") kind = 'I';
+        else if (arg == "-num") kind = 'N';
+        else if (arg == "-str") kind = 'S';
+        else if (argc == 5) {
+            cout << "Unrecognized flag {" << arg << "}" << endl;
+            return 1;
+        }
+        if (kind != 0) termArg = 4; // The term follows the kind flag.
+        if (argc != termArg + 1) {
+            cout << "Usage: -query <index_file> [-id|-num|-str] <term>" << endl;
+            return 1;
+        }
+        return queryIndex(argv[2], argv[termArg], kind);
+    }
+    
+    // Watch mode: keep summaries for a source tree current as files change.
+    if (string(argv[1]) == "-watch") {
+        if (argc != 3) {
+            cout << "Usage: -watch <dir>" << endl;
+            return 1;
+        }
+        return watchDirectory(argv[2]);
+    }
+    
     // Map to store keywords and their corresponding token types.
     map<Token, string> keywordsTokens; 
 
@@ -102,68 +120,31 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Variables to track token count and line number.
-    int tokenCount = 0;
-    int lineNumber = 1;
-    LexItem token;
-    
-    // Set to store found keywords.
-    set<Token> foundkeywordsTokens;
-    
-    // Vector to store all tokens (not currently used in this code).
-    vector<LexItem> allTokens;
+    // Summary of the constants, identifiers and keywords found in the file.
+    TokenSummary summary;
     
-    // Read tokens from the input file until the end is reached.
-    while ((token = getNextToken(infile, lineNumber)).GetToken() != DONE) {
-        if (token.GetToken() == ERR) {
-            cout << token; // Print error token if encountered.
-            return 1;
-        }
-        
-        tokenCount++; // Increment token count.
-      
-        if (showAll) {
-            cout << token; // Print token if -all flag is enabled.
-        }
-        
-        Token t = token.GetToken();
-        
-        // Categorize tokens into identifiers, numeric constants, or string/character constants.
-        if (t == IDENT) {
-            identifiers.insert(token.GetLexeme()); // Store identifier.
-        } 
-        else if (t == ICONST || t == FCONST) {
-            numericConsts.insert(token.GetLexeme()); // Store numeric constant.
-        } 
-        else if (t == SCONST || t == CCONST) {
-            stringAndCharConsts.insert(token.GetLexeme()); // Store string/character constant.
-        } 
-        else {
-            // Check if the token is a keyword.
-            for (const auto& kw : keywords) {
-                if (t == kw.second) {
-                    foundkeywordsTokens.insert(t); // Store found keyword.
-                    break;
-                }
-            }
-        }
+    // Read tokens from the input file until the end is reached, printing each one if -all flag is enabled.
+    LexItem token = summarizeStream(infile, summary, showAll ? &cout : nullptr);
+    if (token.GetToken() == ERR) {
+        cout << token; // Print error token if encountered.
+        return 1;
     }
     
     // Test case summary.
     cout << endl;
-    cout << "Lines: " << lineNumber-1 << endl; // Print total lines processed.
-    cout << "Total Tokens: " << tokenCount << endl; // Print total tokens.
-    cout << "Numerals: " << numericConsts.size() << endl; // Print number of numeric constants.
-    cout << "Characters and Strings : " << stringAndCharConsts.size() << endl; // Print number of string/character constants.
-    cout << "Identifiers: " << identifiers.size() << endl; // Print number of identifiers.
-    cout << "keywords: " << foundkeywordsTokens.size() << endl; // Print number of keywords.
+    cout << "Lines: " << summary.lines << endl; // Print total lines processed.
+    cout << "Total Tokens: " << summary.tokens << endl; // Print total tokens.
+    cout << "Numerals: " << summary.numericConsts.size() << endl; // Print number of numeric constants.
+    cout << "Characters and Strings : " << summary.stringAndCharConsts.size() << endl; // Print number of string/character constants.
+    cout << "Identifiers: " << summary.identifiers.size() << endl; // Print number of identifiers.
+    cout << "keywords: " << summary.keywordsTokens.size() << endl; // Print number of keywords.
     
     // Display numeric constants if -num flag is enabled.
-    if (showNums && !numericConsts.empty()) {
+    if (showNums && !summary.numericConsts.empty()) {
         cout << "NUMERIC CONSTANTS:" << endl;
         
         vector<double> sortedNums;
-        for (const auto& num : numericConsts) {
+        for (const auto& num : summary.numericConsts) {
             double value = stod(num); // Convert string to double.
             sortedNums.push_back(value);
         }
@@ -184,10 +165,10 @@ int main(int argc, char* argv[]) {
     }
     
     // Display string and character constants if -str flag is enabled.
-    if (showStrs && !stringAndCharConsts.empty()) {
+    if (showStrs && !summary.stringAndCharConsts.empty()) {
          bool first = true;
         cout << "CHARACTERS AND STRINGS:" << endl;
-        for (const auto& str : stringAndCharConsts) {
+        for (const auto& str : summary.stringAndCharConsts) {
             if (!first) cout << ", ";
             first = false;
             cout << "\"" << str << "\""; // Print string/character constant.
@@ -196,10 +177,10 @@ int main(int argc, char* argv[]) {
     }
     
     // Display identifiers if -id flag is enabled.
-    if (showIds && !identifiers.empty()) {
+    if (showIds && !summary.identifiers.empty()) {
         cout << "IDENTIFIERS:" << endl;
         bool first = true;
-        for (const auto& id : identifiers) {
+        for (const auto& id : summary.identifiers) {
             if (!first) cout << ", ";
             cout << id; // Print identifier.
             first = false;
@@ -208,13 +189,13 @@ int main(int argc, char* argv[]) {
     }
     
     // Display keywords if -kw flag is enabled.
-    if (showKws && !foundkeywordsTokens.empty()) {
+    if (showKws && !summary.keywordsTokens.empty()) {
         cout << "keywords:" << endl;
         
         vector<string> keywordsName;
         
         // Convert found keywords to lowercase.
-        for (const auto& tokenType : foundkeywordsTokens) {
+        for (const auto& tokenType : summary.keywordsTokens) {
             for (const auto& kw : keywords) {
                 if (tokenType == kw.second) {
                     string lowerkeywords = kw.first;
@@ -0,0 +1,54 @@
+#include "summary.h"
+#include <map>
+
+using namespace std;
+
+// Function to determine how a token is counted in the summary.
+TokenClass classifyToken(Token token) {
+    if (token == IDENT) {
+        return CLASS_IDENT;
+    }
+    if (token == ICONST || token == FCONST) {
+        return CLASS_NUMERIC;
+    }
+    if (token == SCONST || token == CCONST) {
+        return CLASS_STRING;
+    }
+
+    // Token values of the keyword map, built once for quick lookup.
+    static const set<Token> keywordTokens = [] {
+        set<Token> tokens;
+        for (const auto& kw : keywords) {
+            tokens.insert(kw.second);
+        }
+        return tokens;
+    }();
+    return keywordTokens.count(token) ? CLASS_KEYWORD : CLASS_OTHER;
+}
+
+void TokenSummary::Add(const LexItem& tok) {
+    tokens++;
+    switch (classifyToken(tok.GetToken())) {
+        case CLASS_IDENT: identifiers.insert(tok.GetLexeme()); break;
+        case CLASS_NUMERIC: numericConsts.insert(tok.GetLexeme()); break;
+        case CLASS_STRING: stringAndCharConsts.insert(tok.GetLexeme()); break;
+        case CLASS_KEYWORD: keywordsTokens.insert(tok.GetToken()); break;
+        case CLASS_OTHER: break;
+    }
+}
+
+LexItem summarizeStream(istream& in, TokenSummary& summary, ostream* echo) {
+    int lineNumber = 1;
+    LexItem token;
+    while ((token = getNextToken(in, lineNumber)).GetToken() != DONE) {
+        if (token.GetToken() == ERR) {
+            return token;
+        }
+        if (echo) {
+            *echo << token;
+        }
+        summary.Add(token);
+    }
+    summary.lines = lineNumber - 1;
+    return token;
+}
@@ -0,0 +1,61 @@
+/*
+ * summary.h
+ *
+ * Token classification and per-input summaries shared by all modes.
+*/
+
+#ifndef SUMMARY_H_
+#define SUMMARY_H_
+
+#include <set>
+#include <cctype>
+#include <string>
+#include "lex.h"
+using namespace std;
+
+
+// Custom comparator for case-insensitive string comparison.
+struct CaseInsensitiveComp {
+	bool operator()(const string& a, const string& b) const {
+		string lowerA = a, lowerB = b;
+		// Convert both strings to lowercase for comparison.
+		for (size_t i = 0; i < b.length(); i++) {
+			lowerB[i] = tolower(b[i]);
+		}
+		for (size_t i = 0; i < a.length(); i++) {
+			lowerA[i] = tolower(a[i]);
+		}
+		return lowerB > lowerA;
+	}
+};
+
+// How a token is counted in the summary.
+enum TokenClass {
+	CLASS_IDENT,	// IDENT
+	CLASS_NUMERIC,	// ICONST, FCONST
+	CLASS_STRING,	// SCONST, CCONST
+	CLASS_KEYWORD,	// any token in the keyword map
+	CLASS_OTHER,
+};
+
+// Token counts and distinct constants, identifiers and keywords of one input.
+struct TokenSummary {
+	int lines = 0;
+	int tokens = 0;
+	set<string> numericConsts;
+	set<string, CaseInsensitiveComp> identifiers;
+	set<string> stringAndCharConsts;
+	set<Token> keywordsTokens;
+
+	void Add(const LexItem& tok);
+};
+
+
+extern TokenClass classifyToken(Token token);
+// Lexes in until DONE or the first error, adding every token to summary
+// and printing it to echo if one is given. Returns the ERR token on a
+// lexical error, DONE otherwise.
+extern LexItem summarizeStream(istream& in, TokenSummary& summary, ostream* echo = nullptr);
+
+
+#endif /* SUMMARY_H_ */
@@ -0,0 +1,318 @@
+#include "watch.h"
+#include "lex.h"
+#include "summary.h"
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <vector>
+#include <csignal>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// How long the tree must stay quiet before changes are processed.
+const int debounceMs = 100;
+
+// Set by SIGINT or SIGTERM to end the watch loop.
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+// Summary of the whole tree. Each distinct token keeps a count of the
+// files it appears in, so a file's contribution can be subtracted again.
+struct TreeSummary {
+    int lines = 0;
+    int tokens = 0;
+    map<string, int> numericConsts;
+    map<string, int, CaseInsensitiveComp> identifiers;
+    map<string, int> stringAndCharConsts;
+    map<Token, int> keywordsTokens;
+
+    template <class Set, class Map>
+    static void adjust(const Set& values, Map& counts, int delta) {
+        for (const auto& v : values) {
+            if ((counts[v] += delta) == 0) {
+                counts.erase(v);
+            }
+        }
+    }
+
+    void Add(const TokenSummary& f, int delta) {
+        lines += delta * f.lines;
+        tokens += delta * f.tokens;
+        adjust(f.numericConsts, numericConsts, delta);
+        adjust(f.identifiers, identifiers, delta);
+        adjust(f.stringAndCharConsts, stringAndCharConsts, delta);
+        adjust(f.keywordsTokens, keywordsTokens, delta);
+    }
+};
+
+// Lexes one file. Returns false if it cannot be read or has a lexical error.
+bool summarizeFile(const string& path, TokenSummary& summary) {
+    ifstream infile(path);
+    if (!infile) {
+        cout << "CANNOT OPEN THE FILE " << path << endl;
+        return false;
+    }
+
+    LexItem token = summarizeStream(infile, summary);
+    if (token.GetToken() == ERR) {
+        cout << path << ": " << token;
+        return false;
+    }
+    return true;
+}
+
+// True if two summaries contribute the same counts to the tree.
+bool sameSummary(const TokenSummary& a, const TokenSummary& b) {
+    return a.lines == b.lines && a.tokens == b.tokens && a.numericConsts == b.numericConsts
+        && a.identifiers == b.identifiers && a.stringAndCharConsts == b.stringAndCharConsts
+        && a.keywordsTokens == b.keywordsTokens;
+}
+
+// Hidden files, editor backups and the temporary files written by -index are not sources.
+bool isSourceName(const string& name) {
+    const string tmpSuffix = ".tmp";
+    if (name.empty() || name[0] == '.' || name.back() == '~') return false;
+    return name.size() < tmpSuffix.size() || name.compare(name.size() - tmpSuffix.size(), tmpSuffix.size(), tmpSuffix) != 0;
+}
+
+// Binary files, such as an index, object files or the analyzer itself, contain NUL bytes near the start.
+bool isTextFile(const string& path) {
+    ifstream infile(path, ios::binary);
+    char buf[4096];
+    infile.read(buf, sizeof(buf));
+    return memchr(buf, '\0', infile.gcount()) == nullptr;
+}
+
+class TreeWatcher {
+    int fd;
+    map<int, string> watchDirs; // Watch descriptor to directory path.
+    map<string, TokenSummary> files;
+    TreeSummary tree;
+
+    // Watches dir and its subdirectories, adding the source files found to dirty.
+    void addTree(const string& dir, set<string>& dirty) {
+        int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE);
+        if (wd < 0) {
+            cout << "CANNOT WATCH THE DIRECTORY " << dir << endl;
+            return;
+        }
+        // The same directory reached through another path is already watched.
+        if (!watchDirs.emplace(wd, dir).second) return;
+        scanDir(dir, dirty);
+    }
+
+    // Adds the source files in dir to dirty and watches any new subdirectories.
+    void scanDir(const string& dir, set<string>& dirty) {
+        DIR* d = opendir(dir.c_str());
+        if (!d) return;
+        while (struct dirent* entry = readdir(d)) {
+            string name = entry->d_name;
+            if (!isSourceName(name)) continue;
+
+            string path = dir + "/" + name;
+            struct stat st;
+            if (lstat(path.c_str(), &st) != 0) continue;
+            if (S_ISLNK(st.st_mode)) {
+                // Follow links to files, but not to directories, which would be walked twice or loop.
+                if (stat(path.c_str(), &st) != 0 || S_ISDIR(st.st_mode)) continue;
+            }
+            if (S_ISDIR(st.st_mode)) addTree(path, dirty);
+            else if (S_ISREG(st.st_mode)) dirty.insert(path);
+        }
+        closedir(d);
+    }
+
+    // Replaces the contribution of each dirty file with its current one.
+    // Returns a report line for every file whose contribution changed.
+    vector<string> update(const set<string>& dirty) {
+        vector<string> report;
+        for (const auto& path : dirty) {
+            auto old = files.find(path);
+            bool known = old != files.end();
+
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+                // Deleted or moved away.
+                if (known) forget(old, report, "Removed: ");
+                continue;
+            }
+            if (!isTextFile(path)) {
+                if (known) forget(old, report, "Removed (not text): ");
+                continue;
+            }
+            TokenSummary summary;
+            if (!summarizeFile(path, summary)) {
+                if (known) forget(old, report, "Removed (lexical error): ");
+                continue;
+            }
+
+            if (known) {
+                if (sameSummary(old->second, summary)) continue; // Rewritten with the same tokens.
+                tree.Add(old->second, -1);
+                report.push_back("Changed: " + path);
+            }
+            else {
+                report.push_back("Added: " + path);
+            }
+            tree.Add(summary, 1);
+            files[path] = summary;
+        }
+        return report;
+    }
+
+    // Drops a file's contribution and records why.
+    void forget(map<string, TokenSummary>::iterator file, vector<string>& report, const string& reason) {
+        report.push_back(reason + file->first);
+        tree.Add(file->second, -1);
+        files.erase(file);
+    }
+
+    void printSummary() const {
+        cout << endl;
+        cout << "Files: " << files.size() << endl;
+        cout << "Lines: " << tree.lines << endl;
+        cout << "Total Tokens: " << tree.tokens << endl;
+        cout << "Numerals: " << tree.numericConsts.size() << endl;
+        cout << "Characters and Strings : " << tree.stringAndCharConsts.size() << endl;
+        cout << "Identifiers: " << tree.identifiers.size() << endl;
+        cout << "keywords: " << tree.keywordsTokens.size() << endl;
+    }
+
+    // Reads all pending events, collecting changed files into dirty.
+    void readEvents(set<string>& dirty) {
+        alignas(struct inotify_event) char buf[4096];
+        ssize_t len = read(fd, buf, sizeof(buf));
+        for (char* p = buf; len > 0 && p < buf + len; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost; recheck every known file and rescan the tree.
+                for (const auto& f : files) dirty.insert(f.first);
+                set<string> dirs;
+                for (const auto& w : watchDirs) dirs.insert(w.second);
+                for (const auto& dir : dirs) scanDir(dir, dirty);
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watchDirs.erase(event->wd);
+                continue;
+            }
+
+            auto dir = watchDirs.find(event->wd);
+            if (dir == watchDirs.end() || event->len == 0 || !isSourceName(event->name)) continue;
+            string path = dir->second + "/" + event->name;
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) addTree(path, dirty);
+                else forgetTree(path, dirty);
+            }
+            else {
+                // A file may be lexed while still partly written; its IN_CLOSE_WRITE corrects it.
+                dirty.insert(path);
+            }
+        }
+    }
+
+    // Stops watching a removed directory and marks its files so their contribution is dropped.
+    void forgetTree(const string& dir, set<string>& dirty) {
+        string prefix = dir + "/";
+        for (const auto& f : files) {
+            if (f.first.compare(0, prefix.size(), prefix) == 0) dirty.insert(f.first);
+        }
+        for (const auto& w : watchDirs) {
+            if (w.second == dir || w.second.compare(0, prefix.size(), prefix) == 0) {
+                inotify_rm_watch(fd, w.first); // Its IN_IGNORED event erases the entry.
+            }
+        }
+    }
+
+public:
+    explicit TreeWatcher(int fd) : fd(fd) {}
+
+    bool Start(const string& dir) {
+        set<string> dirty;
+        addTree(dir, dirty);
+        if (watchDirs.empty()) return false;
+        update(dirty);
+        printSummary();
+        return true;
+    }
+
+    // Processes changes until SIGINT or SIGTERM sets stopRequested.
+    void Run() {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        while (!stopRequested) {
+            if (poll(&pfd, 1, -1) <= 0) continue; // Interrupted by a signal, or nothing to read.
+
+            // Debounce: keep collecting until no event arrives for debounceMs.
+            set<string> dirty;
+            do {
+                readEvents(dirty);
+            } while (poll(&pfd, 1, debounceMs) > 0);
+            if (dirty.empty()) continue;
+
+            auto start = chrono::steady_clock::now();
+            vector<string> report = update(dirty);
+            auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+            if (report.empty()) continue;
+
+            cout << endl;
+            for (const auto& line : report) {
+                cout << line << endl;
+            }
+            cout << "Re-lexed in " << elapsed.count() << " ms" << endl;
+            printSummary();
+        }
+    }
+};
+
+} // namespace
+
+int watchDirectory(const string& dir) {
+    struct stat st;
+    if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        cout << "CANNOT OPEN THE DIRECTORY " << dir << endl;
+        return 1;
+    }
+
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        cout << "CANNOT START WATCHING " << dir << endl;
+        return 1;
+    }
+
+    string root = dir;
+    while (root.size() > 1 && root.back() == '/') {
+        root.pop_back();
+    }
+
+    // No SA_RESTART, so a blocked poll returns and the loop sees stopRequested.
+    struct sigaction action = {};
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    TreeWatcher watcher(fd);
+    if (!watcher.Start(root)) {
+        close(fd);
+        return 1;
+    }
+    watcher.Run();
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,22 @@
+/*
+ * watch.h
+ *
+ * Watch mode: keeps token summaries for a source tree up to date.
+*/
+
+#ifndef WATCH_H_
+#define WATCH_H_
+
+#include <string>
+using namespace std;
+
+
+// Lexes every source file under dir, prints the combined summary, then
+// waits for changes with inotify. After each burst of changes only the
+// modified files are lexed again and the summary is printed again.
+// Runs until SIGINT or SIGTERM and then returns 0; returns 1 if the
+// directory cannot be watched.
+extern int watchDirectory(const string& dir);
+
+
+#endif /* WATCH_H_ */